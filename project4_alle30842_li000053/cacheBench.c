@@ -0,0 +1,398 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "cacheModel.h"
+
+#define NUMMEMORY 65536 /* must match the simulator */
+
+#define ADD 0
+#define NAND 1
+#define LW 2
+#define SW 3
+#define BEQ 4
+#define JALR 5
+#define HALT 6
+#define NOOP 7
+
+// Layout of the generated programs: code from 0, constants from CONSTBASE, data from DATABASE
+#define CONSTBASE 100
+#define DATABASE 128
+#define DATAWORDS 32768
+#define PASSES 32 /* passes over the data by the sequential pattern, strided makes 17 times as many */
+
+enum pattern_type {sequential, strided, pointer_chase, tight_loop};
+
+// Structures
+typedef struct geometryStruct {
+	int wordsPerBlock;
+	int sets;
+	int ways;
+} geometryType;
+
+typedef struct resultStruct {
+	long long accesses;
+	long long hits;
+	double seconds;
+	long peakRssKb;
+} resultType;
+
+// Geometries every pattern is run against, from a tiny direct mapped cache up to one larger than the data
+static const geometryType geometries[] = {
+	{4, 2, 1},
+	{1, 1, 8},
+	{4, 64, 2},
+	{8, 256, 4},
+	{16, 1024, 8},
+};
+#define NUMGEOMETRIES ((int)(sizeof(geometries) / sizeof(geometries[0])))
+
+static const enum pattern_type patterns[] = {sequential, strided, pointer_chase, tight_loop};
+#define NUMPATTERNS ((int)(sizeof(patterns) / sizeof(patterns[0])))
+
+// Functions
+char* getPatternName(enum pattern_type pattern)
+{
+   switch (pattern)
+   {
+      case sequential: return "sequential";
+      case strided: return "strided";
+      case pointer_chase: return "pointer_chase";
+      case tight_loop: return "tight_loop";
+      default: return "invalid pattern enum val";
+   }
+}
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Fill next[] with a single random cycle through all count nodes (Sattolo's algorithm)
+static void buildChain(int* next, int count){
+	for (int i = 0; i < count; i++ ){
+		next[i] = i;
+	}
+	for (int i = count - 1; i > 0; i-- ){
+		int j = rand() % i;
+		int tmp = next[i];
+		next[i] = next[j];
+		next[j] = tmp;
+	}
+}
+
+static int encode(int op, int regA, int regB, int offset){
+	return (op << 22) | (regA << 19) | (regB << 16) | (offset & 0xFFFF);
+}
+
+/*
+* Build the LC-2K machine code for a pattern into mem.
+*
+* scale multiplies the amount of work. Every program keeps its loop counters in
+* registers and only touches memory through its data accesses and instruction fetches.
+*/
+static void buildProgram(enum pattern_type pattern, int scale, int* mem){
+	int pc = 0;
+	memset(mem, 0, NUMMEMORY * sizeof(int));
+	mem[CONSTBASE + 1] = -1;
+
+	if (pattern == sequential || pattern == strided){
+		int stride = (pattern == sequential) ? 1 : 17;
+		int op = (pattern == sequential) ? LW : SW;
+		// one pass touches DATAWORDS / stride words, stride 17 wraps blocks of any size
+		mem[CONSTBASE] = PASSES * stride * scale;
+		mem[CONSTBASE + 2] = stride;
+		mem[CONSTBASE + 3] = (DATAWORDS / stride) * stride;
+		mem[pc++] = encode(LW, 5, 0, CONSTBASE);      // r5 = passes
+		mem[pc++] = encode(LW, 6, 0, CONSTBASE + 1);  // r6 = -1
+		mem[pc++] = encode(LW, 3, 0, CONSTBASE + 2);  // r3 = stride
+		mem[pc++] = encode(LW, 4, 0, CONSTBASE + 3);  // r4 = limit
+		mem[pc++] = encode(ADD, 0, 0, 2);             // outer: r2 = 0
+		mem[pc++] = encode(op, 1, 2, DATABASE);       // inner: access data[r2]
+		mem[pc++] = encode(ADD, 2, 3, 2);             // r2 += stride
+		mem[pc++] = encode(BEQ, 2, 4, 1);             // end of pass
+		mem[pc++] = encode(BEQ, 0, 0, -4);            // goto inner
+		mem[pc++] = encode(ADD, 5, 6, 5);             // passes--
+		mem[pc++] = encode(BEQ, 5, 0, 1);             // done
+		mem[pc++] = encode(BEQ, 0, 0, -8);            // goto outer
+		mem[pc++] = encode(HALT, 0, 0, 0);
+	}
+	else if (pattern == pointer_chase){
+		mem[CONSTBASE] = PASSES * DATAWORDS * scale;
+		buildChain(&mem[DATABASE], DATAWORDS);
+		mem[pc++] = encode(LW, 5, 0, CONSTBASE);      // r5 = steps
+		mem[pc++] = encode(LW, 6, 0, CONSTBASE + 1);  // r6 = -1
+		mem[pc++] = encode(LW, 2, 2, DATABASE);       // loop: r2 = data[r2]
+		mem[pc++] = encode(ADD, 5, 6, 5);             // steps--
+		mem[pc++] = encode(BEQ, 5, 0, 1);             // done
+		mem[pc++] = encode(BEQ, 0, 0, -4);            // goto loop
+		mem[pc++] = encode(HALT, 0, 0, 0);
+	}
+	else{
+		mem[CONSTBASE] = PASSES * DATAWORDS / 2 * scale;
+		mem[CONSTBASE + 2] = 63;
+		mem[CONSTBASE + 3] = 1;
+		mem[pc++] = encode(LW, 5, 0, CONSTBASE);      // r5 = iterations
+		mem[pc++] = encode(LW, 6, 0, CONSTBASE + 1);  // r6 = -1
+		mem[pc++] = encode(LW, 3, 0, CONSTBASE + 2);  // r3 = 63
+		mem[pc++] = encode(LW, 4, 0, CONSTBASE + 3);  // r4 = 1
+		mem[pc++] = encode(NAND, 2, 3, 7);            // loop: r7 = r2 & 63
+		mem[pc++] = encode(NAND, 7, 7, 7);
+		mem[pc++] = encode(LW, 1, 7, DATABASE);       // read data[r7]
+		mem[pc++] = encode(SW, 1, 7, DATABASE);       // write it back
+		mem[pc++] = encode(ADD, 2, 4, 2);             // r2++
+		mem[pc++] = encode(ADD, 5, 6, 5);             // iterations--
+		mem[pc++] = encode(BEQ, 5, 0, 1);             // done
+		mem[pc++] = encode(BEQ, 0, 0, -8);            // goto loop
+		mem[pc++] = encode(HALT, 0, 0, 0);
+	}
+}
+
+/*
+* Build the address trace for a pattern, the data accesses of the matching
+* program without its instruction fetches. Returns the number of requests.
+*/
+static int buildTrace(enum pattern_type pattern, int scale, cacheRequestType* requests, int maxRequests){
+	int count = 0;
+
+	if (pattern == sequential || pattern == strided){
+		int stride = (pattern == sequential) ? 1 : 17;
+		enum access_type action = (pattern == sequential) ? read_mem : write_mem;
+		for (int pass = 0; pass < PASSES * stride * scale; pass++ ){
+			for (int i = 0; i + stride <= DATAWORDS && count < maxRequests; i += stride ){
+				requests[count].address = DATABASE + i;
+				requests[count].action = action;
+				requests[count].writeValue = i;
+				count++;
+			}
+		}
+	}
+	else if (pattern == pointer_chase){
+		int* next = (int*)malloc(DATAWORDS * sizeof(int));
+		buildChain(next, DATAWORDS);
+		int node = 0;
+		for (int i = 0; i < PASSES * DATAWORDS * scale && count < maxRequests; i++ ){
+			requests[count].address = DATABASE + node;
+			requests[count].action = read_mem;
+			requests[count].writeValue = 0;
+			node = next[node];
+			count++;
+		}
+		free(next);
+	}
+	else{
+		// a 64 word working set, each word read then written back
+		for (int i = 0; i < PASSES * DATAWORDS / 2 * scale && count + 1 < maxRequests; i++ ){
+			requests[count].address = DATABASE + (i & 63);
+			requests[count].action = read_mem;
+			requests[count].writeValue = 0;
+			requests[count + 1] = requests[count];
+			requests[count + 1].action = write_mem;
+			count += 2;
+		}
+	}
+	return count;
+}
+
+/*
+* Build the trace for a pattern and run it through the cache model in a single
+* batch, in a child process so that the peak RSS is that of this run alone.
+*/
+static resultType runTrace(enum pattern_type pattern, int scale, geometryType geometry){
+	resultType result;
+	memset(&result, 0, sizeof(resultType));
+
+	int fds[2];
+	if (pipe(fds) != 0){
+		printf("Cannot create pipe : %s\n", strerror(errno));
+		exit(1);
+	}
+
+	pid_t pid = fork();
+	if (pid == 0){
+		close(fds[0]);
+		int* mem = (int*)calloc(NUMMEMORY, sizeof(int));
+		int maxRequests = PASSES * scale * DATAWORDS;
+		cacheRequestType* requests = (cacheRequestType*)malloc(maxRequests * sizeof(cacheRequestType));
+		cacheType* cache = cacheCreate();
+		if (mem == NULL || requests == NULL || cache == NULL ||
+			cacheConfigure(cache, geometry.wordsPerBlock, geometry.sets, geometry.ways, mem, NUMMEMORY) != 0){
+			_exit(1);
+		}
+		int count = buildTrace(pattern, scale, requests, maxRequests);
+
+		cacheStatsType stats;
+		double start = now();
+		cacheAccessBatch(cache, requests, count, NULL, NULL, &stats);
+		result.seconds = now() - start;
+		result.accesses = stats.accesses;
+		result.hits = stats.hits;
+
+		int ok = write(fds[1], &result, sizeof(resultType)) == (ssize_t)sizeof(resultType);
+		_exit(ok ? 0 : 1);
+	}
+	close(fds[1]);
+
+	int received = read(fds[0], &result, sizeof(resultType)) == (ssize_t)sizeof(resultType);
+	close(fds[0]);
+
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	result.peakRssKb = usage.ru_maxrss;
+
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+		printf("Cannot run trace %s on cache %d.%d.%d\n", getPatternName(pattern),
+			geometry.wordsPerBlock, geometry.sets, geometry.ways);
+		exit(1);
+	}
+	return result;
+}
+
+/*
+* Run the simulator binary on a program file in quiet mode and read back its totals.
+* The time is the one the simulator reports for its run loop, so loading the
+* program is not counted. Peak RSS is that of the simulator process.
+*/
+static resultType runProgram(const char* simPath, const char* fname, geometryType geometry){
+	resultType result;
+	memset(&result, 0, sizeof(resultType));
+
+	char b[16], s[16], a[16];
+	snprintf(b, sizeof(b), "%d", geometry.wordsPerBlock);
+	snprintf(s, sizeof(s), "%d", geometry.sets);
+	snprintf(a, sizeof(a), "%d", geometry.ways);
+
+	int fds[2];
+	if (pipe(fds) != 0){
+		printf("Cannot create pipe : %s\n", strerror(errno));
+		exit(1);
+	}
+
+	pid_t pid = fork();
+	if (pid == 0){
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execl(simPath, simPath, "-q", "-f", fname, "-b", b, "-s", s, "-a", a, (char*)NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+
+	FILE* out = fdopen(fds[0], "r");
+	char line[256];
+	while (fgets(line, sizeof(line), out)) {
+		sscanf(line, "accesses: %lld", &result.accesses);
+		sscanf(line, "hits: %lld", &result.hits);
+		sscanf(line, "seconds: %lf", &result.seconds);
+	}
+	fclose(out);
+
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	result.peakRssKb = usage.ru_maxrss;
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.accesses == 0){
+		printf("Simulator failed on %s\n", fname);
+		exit(1);
+	}
+	return result;
+}
+
+static void printHeader(const char* title){
+	printf("\n%s\n", title);
+	printf("%-14s %-10s %12s %8s %12s %10s %10s\n",
+		"pattern", "b.s.a", "accesses", "hit%", "accesses/s", "ns/access", "peakRSS(KB)");
+}
+
+static void printResult(enum pattern_type pattern, geometryType geometry, resultType result){
+	char geometryName[32];
+	snprintf(geometryName, sizeof(geometryName), "%d.%d.%d", geometry.wordsPerBlock, geometry.sets, geometry.ways);
+	double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+	printf("%-14s %-10s %12lld %8.2f %12.0f %10.2f %10ld\n",
+		getPatternName(pattern), geometryName, result.accesses,
+		100.0 * result.hits / result.accesses,
+		result.accesses / seconds, 1e9 * seconds / result.accesses, result.peakRssKb);
+}
+
+int main(int argc, char** argv){
+	char* simPath = "./cacheSim";
+	int scale = 1;
+	int cin = 0;
+
+	while((cin = getopt(argc, argv, "x:p:")) != -1){
+		switch(cin)
+		{
+			case 'x':
+				scale = atoi(optarg);
+				break;
+			case 'p':
+				simPath = optarg;
+				break;
+			default:
+				printf("Usage: %s [-x scale] [-p path to cacheSim]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (scale < 1){
+		scale = 1;
+	}
+	srand(340);
+
+	int* mem = (int*)malloc(NUMMEMORY * sizeof(int));
+	if (mem == NULL){
+		printf("Out of memory\n");
+		return 1;
+	}
+
+	/** Cache model on address traces **/
+	printHeader("Cache model, batched traces");
+	for (int p = 0; p < NUMPATTERNS; p++ ){
+		for (int g = 0; g < NUMGEOMETRIES; g++ ){
+			printResult(patterns[p], geometries[g], runTrace(patterns[p], scale, geometries[g]));
+		}
+	}
+
+	/** Full simulator on generated LC-2K programs **/
+	char dir[] = "/tmp/cacheBench.XXXXXX";
+	if (mkdtemp(dir) == NULL){
+		printf("Cannot create temporary directory : %s\n", strerror(errno));
+		return 1;
+	}
+
+	printHeader("Simulator, LC-2K programs");
+	for (int p = 0; p < NUMPATTERNS; p++ ){
+		char fname[64];
+		snprintf(fname, sizeof(fname), "%s/%s.mc", dir, getPatternName(patterns[p]));
+
+		buildProgram(patterns[p], scale, mem);
+		FILE* fp = fopen(fname, "w");
+		if (fp == NULL) {
+			printf("Cannot open file '%s' : %s\n", fname, strerror(errno));
+			return 1;
+		}
+		for (int i = 0; i < DATABASE + DATAWORDS; i++ ){
+			fprintf(fp, "%d\n", mem[i]);
+		}
+		fclose(fp);
+
+		for (int g = 0; g < NUMGEOMETRIES; g++ ){
+			printResult(patterns[p], geometries[g], runProgram(simPath, fname, geometries[g]));
+		}
+		unlink(fname);
+	}
+	rmdir(dir);
+
+	free(mem);
+	return 0;
+}
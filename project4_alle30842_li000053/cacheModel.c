@@ -0,0 +1,481 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cacheModel.h"
+
+// How one cache line is laid out in a saved state, followed by its data words
+typedef struct savedLineStruct {
+	int dirtyBit;
+	int validBit;
+	int tag;
+	int unused;
+	long long lastUse;
+} savedLineType;
+
+// Functions
+static int logTwo(int num){
+	int bits = 0;
+	while ((1 << bits) < num){
+		bits++;
+	}
+	return bits;
+}
+
+static int isPowerOfTwo(int num){
+	return num > 0 && (num & (num - 1)) == 0;
+}
+
+static void logAction(cacheType* cache, int address, int size, enum action_type type){
+	if (cache->logger != NULL){
+		cache->logger(address, size, type);
+	}
+}
+
+// return 1 if the whole block starting at base lies inside the backing memory
+static int blockInMemory(cacheType* cache, int base){
+	return base >= 0 && (base & cache->blkOffsetMask) == 0 && base <= cache->numMemory - cache->wordsPerBlock;
+}
+
+// where the block starting at base is kept in the backing memory
+static int memAddress(cacheType* cache, int base){
+	if (cache->translator != NULL){
+		base = cache->translator(cache->translatorContext, base);
+		// a translator that maps a block outside of memory is a bug in the caller
+		if (!blockInMemory(cache, base)){
+			abort();
+		}
+	}
+	return base;
+}
+
+static void freeCacheArr(cacheType* cache){
+	if (cache->cacheArr != NULL){
+		// every block's data and every set's ways live in one allocation each
+		free(cache->cacheArr[0][0].data);
+		free(cache->cacheArr[0]);
+		free(cache->cacheArr);
+		cache->cacheArr = NULL;
+	}
+}
+
+// return an unconfigured cache, or NULL if out of memory
+cacheType* cacheCreate(void){
+	cacheType* cache = (cacheType*)malloc(sizeof(cacheType));
+	if (cache == NULL){
+		return NULL;
+	}
+	memset(cache, 0, sizeof(cacheType));
+	cache->cacheArr = NULL;
+	cache->logger = NULL;
+	cache->translator = NULL;
+	cache->translatorContext = NULL;
+	return cache;
+}
+
+/*
+* Set the geometry of the cache and the memory it is backed by.
+*
+* wordsPerBlock, sets and ways must be powers of two. mem is owned by the caller
+* and must hold numMemory words, a whole number of blocks. Any previous contents of the cache are dropped
+* and the statistics are reset. Returns 0 on success and -1 on bad arguments or
+* if out of memory.
+*/
+int cacheConfigure(cacheType* cache, int wordsPerBlock, int sets, int ways, int* mem, int numMemory){
+	if (!isPowerOfTwo(wordsPerBlock) || !isPowerOfTwo(sets) || !isPowerOfTwo(ways)){
+		return -1;
+	}
+	if (mem == NULL || numMemory < wordsPerBlock || numMemory % wordsPerBlock != 0){
+		return -1;
+	}
+
+	freeCacheArr(cache);
+
+	cache->sets = sets;
+	cache->ways = ways;
+	cache->wordsPerBlock = wordsPerBlock;
+	cache->blkOffsetBits = logTwo(wordsPerBlock);
+	cache->setBits = logTwo(sets);
+	cache->blkOffsetMask = wordsPerBlock - 1;
+	cache->setMask = sets - 1;
+	cache->mem = mem;
+	cache->numMemory = numMemory;
+	cache->useClock = 0;
+	memset(&cache->stats, 0, sizeof(cacheStatsType));
+
+	// Alocate our cache array the size of the number of sets/lines we have contaning pointers to the array of blocks in each set
+	cache->cacheArr = (cacheEntryType**)malloc(sets * sizeof(cacheEntryType*));
+	cacheEntryType* entries = (cacheEntryType*)malloc((size_t)sets * ways * sizeof(cacheEntryType));
+	int* data = (int*)calloc((size_t)sets * ways * wordsPerBlock, sizeof(int));
+	if (cache->cacheArr == NULL || entries == NULL || data == NULL){
+		free(cache->cacheArr);
+		free(entries);
+		free(data);
+		cache->cacheArr = NULL;
+		return -1;
+	}
+
+	for (int set = 0; set < sets; set++ ){
+		cache->cacheArr[set] = &entries[set * ways];
+		for (int way = 0; way < ways; way++ ){
+			cache->cacheArr[set][way].dirtyBit = clean;
+			cache->cacheArr[set][way].validBit = invalid;
+			cache->cacheArr[set][way].tag = 0;
+			cache->cacheArr[set][way].lastUse = 0;
+			cache->cacheArr[set][way].data = &data[((size_t)set * ways + way) * wordsPerBlock];
+		}
+	}
+	return 0;
+}
+
+void cacheDestroy(cacheType* cache){
+	if (cache == NULL){
+		return;
+	}
+	freeCacheArr(cache);
+	free(cache);
+}
+
+int getTag(int address, cacheType* cache){
+	//cut all the bits which represent the set number and block offset.
+	return address >> (cache->blkOffsetBits + cache->setBits);
+}
+
+int getSet(int address, cacheType* cache){
+	//cut all block offset bits then mask off the set bits
+	return (address >> cache->blkOffsetBits) & cache->setMask;
+}
+
+int getBlkOffset(int address, cacheType* cache){
+	return address & cache->blkOffsetMask;
+}
+
+//get the base address based on the given address
+int getAddressBase(int address, cacheType* cache){
+	return address & (~cache->blkOffsetMask);
+}
+
+//build back the address based on tag, set, and block offset
+int buildAddress(int tag, int set, int blockOffset, cacheType* cache){
+	//left shift every element in correct position
+	tag = tag << (cache->setBits + cache->blkOffsetBits);
+	set = set << cache->blkOffsetBits;
+
+	return tag | set | blockOffset;
+}
+
+// number of accesses since the block in the given set and way was filled
+long long getCyclesSinceLastUse(cacheType* cache, int set, int way){
+	return cache->useClock - cache->cacheArr[set][way].lastUse;
+}
+
+// return >= 0 way contaning the address if the given address is in cache otherwise -1
+int searchCache(int address, cacheType* cache){
+	int set = getSet(address, cache);
+	int tag = getTag(address, cache);
+	cacheEntryType* ways = cache->cacheArr[set];
+	// loop through all the ways of the address's set
+	for (int way = 0; way < cache->ways; way++ ){
+		// if the tag is found in the set return the way
+		if (ways[way].validBit == valid && ways[way].tag == tag){
+			return way;
+		}
+	}
+	// otherwise return -1
+	return -1;
+}
+
+// Returns the way in the cach set corisponding to the given address that can be overwriten
+int alocateCacheLine(int address, cacheType* cache){
+	int set = getSet(address, cache);
+	cacheEntryType* ways = cache->cacheArr[set];
+	int lru = 0;
+	// loop through all the ways of a set
+	for (int way = 0; way < cache->ways; way++ ){
+		// If the current way is invalid return it to be overwriten
+		if (ways[way].validBit == invalid){
+			return way;
+		}
+		// If the current line was last used before the current lru change the lru to the current way
+		if (ways[way].lastUse < ways[lru].lastUse){
+			lru = way;
+		}
+	}
+	// check if the lru way needs to be written back to memory
+	int lruAddress = buildAddress(ways[lru].tag, set, 0, cache);
+	if (ways[lru].dirtyBit == dirty){
+		cacheToMem(lruAddress, cache, lru);
+	}
+	else{
+		ways[lru].validBit = invalid;
+		cache->stats.evictions++;
+		logAction(cache, getAddressBase(lruAddress, cache), cache->wordsPerBlock, cache_to_nowhere);
+	}
+	return lru;
+}
+
+int memToCache(int address, cacheType* cache){
+	int tag = getTag(address, cache);
+	int set = getSet(address, cache);
+	int base = getAddressBase(address, cache);
+
+	//find the available way in the set to write
+	int way_to_write = alocateCacheLine(address, cache);
+	cacheEntryType* entry = &cache->cacheArr[set][way_to_write];
+
+	//overwrite the the way with the new data from mem
+	entry->dirtyBit = clean;
+	entry->validBit = valid;
+	entry->tag = tag;
+	entry->lastUse = cache->useClock;
+	memcpy(entry->data, &cache->mem[memAddress(cache, base)], cache->wordsPerBlock * sizeof(int));
+
+	logAction(cache, base, cache->wordsPerBlock, memory_to_cache);
+	return way_to_write;
+}
+
+void cacheToMem(int address, cacheType* cache, int way){
+	int set = getSet(address, cache);
+	int base = getAddressBase(address, cache);
+	cacheEntryType* entry = &cache->cacheArr[set][way];
+
+	// only dirty blocks need to be written back to memory
+	if (entry->dirtyBit == dirty){
+		memcpy(&cache->mem[memAddress(cache, base)], entry->data, cache->wordsPerBlock * sizeof(int));
+		cache->stats.writeBacks++;
+		logAction(cache, base, cache->wordsPerBlock, cache_to_memory);
+	}
+	// make cache entry invalid
+	entry->validBit = invalid;
+}
+
+/*
+* Perform one access against the cache.
+*
+* read_mem returns the word at address, write_mem stores write_value at address
+* and halt writes every dirty block back to memory and invalidates the cache.
+* Transfers between the cache and memory are reported to the logger; transfers
+* to and from the processor are left to the caller. Returns -1 for writes and
+* halt. The address of a read or write must lie inside memory, the model aborts
+* rather than overrun it; cacheAccessBatch rejects such addresses instead.
+*/
+int cacheAccess(cacheType* cache, int address, enum access_type action, int write_value){
+	if (action != halt && (address < 0 || address >= cache->numMemory)){
+		abort();
+	}
+	cache->useClock++;
+
+	if (action == halt){
+		// loop through all sets of cache
+		for (int set = 0; set < cache->sets; set++ ){
+			// loop through all the ways of a set
+			for (int way = 0; way < cache->ways; way++ ){
+				// if the way contains valid dirty data make its address and write that block to memory
+				if(cache->cacheArr[set][way].validBit == valid && cache->cacheArr[set][way].dirtyBit == dirty){
+					int moveAddress = buildAddress(cache->cacheArr[set][way].tag, set, 0, cache);
+					cacheToMem(moveAddress, cache, way);
+				}
+				// invalidate all cache lines
+				cache->cacheArr[set][way].validBit = invalid;
+			}
+		}
+		return -1;
+	}
+	else if (action != read_mem && action != write_mem){
+		abort();
+	}
+
+	int set = getSet(address, cache);
+	int blkOffset = getBlkOffset(address, cache);
+	int way = searchCache(address, cache);
+
+	cache->stats.accesses++;
+	if (way == -1){
+		cache->stats.misses++;
+		way = memToCache(address, cache);
+	}
+	else{
+		cache->stats.hits++;
+	}
+	cacheEntryType* entry = &cache->cacheArr[set][way];
+
+	//processor read from mem
+	if (action == read_mem){
+		cache->stats.reads++;
+		return entry->data[blkOffset];
+	}
+
+	//process write to mem
+	cache->stats.writes++;
+	entry->data[blkOffset] = write_value;
+	entry->dirtyBit = dirty;
+	return -1;
+}
+
+/*
+* Perform count accesses in order without logging.
+*
+* readValues, if not NULL, receives the value returned by each access.
+* hitBitmap, if not NULL, must hold (count + 7) / 8 bytes; bit i (LSB first) is
+* set when access i hit and is left clear for misses and halt entries.
+* stats, if not NULL, receives the counters for this batch only; the running
+* totals in cache->stats are updated as well.
+* Returns the number of hits, or -1 without touching the cache if any read or
+* write address is outside of memory. The check is made on the addresses as
+* given, the translator is only called by the accesses themselves.
+*/
+int cacheAccessBatch(cacheType* cache, const cacheRequestType* requests, int count,
+	int* readValues, unsigned char* hitBitmap, cacheStatsType* stats){
+	for (int i = 0; i < count; i++ ){
+		if (requests[i].action != halt && (requests[i].address < 0 || requests[i].address >= cache->numMemory)){
+			return -1;
+		}
+	}
+
+	cacheStatsType before = cache->stats;
+	cacheLoggerType logger = cache->logger;
+	cache->logger = NULL;
+
+	if (hitBitmap != NULL){
+		memset(hitBitmap, 0, ((size_t)count + 7) / 8);
+	}
+
+	for (int i = 0; i < count; i++ ){
+		long long hitsBefore = cache->stats.hits;
+		int value = cacheAccess(cache, requests[i].address, requests[i].action, requests[i].writeValue);
+		if (readValues != NULL){
+			readValues[i] = value;
+		}
+		if (hitBitmap != NULL && cache->stats.hits != hitsBefore){
+			hitBitmap[i >> 3] |= (unsigned char)(1 << (i & 7));
+		}
+	}
+
+	cache->logger = logger;
+
+	if (stats != NULL){
+		stats->accesses = cache->stats.accesses - before.accesses;
+		stats->reads = cache->stats.reads - before.reads;
+		stats->writes = cache->stats.writes - before.writes;
+		stats->hits = cache->stats.hits - before.hits;
+		stats->misses = cache->stats.misses - before.misses;
+		stats->writeBacks = cache->stats.writeBacks - before.writeBacks;
+		stats->evictions = cache->stats.evictions - before.evictions;
+	}
+	return (int)(cache->stats.hits - before.hits);
+}
+
+// number of bytes cacheWriteState writes for this cache
+long cacheStateSize(cacheType* cache){
+	long lines = (long)cache->sets * cache->ways;
+	return sizeof(long long) + sizeof(cacheStatsType) +
+		lines * (sizeof(savedLineType) + cache->wordsPerBlock * sizeof(int));
+}
+
+/*
+* Write the use clock, the statistics and every line of the cache, including its
+* dirty, valid and replacement state, to fp. The geometry is not written; the
+* reader must configure an identical cache. Returns 0 on success and -1 on a
+* write error.
+*/
+int cacheWriteState(cacheType* cache, FILE* fp){
+	int ok = 1;
+	ok = ok && fwrite(&cache->useClock, sizeof(long long), 1, fp) == 1;
+	ok = ok && fwrite(&cache->stats, sizeof(cacheStatsType), 1, fp) == 1;
+	for (int set = 0; set < cache->sets && ok; set++ ){
+		for (int way = 0; way < cache->ways && ok; way++ ){
+			cacheEntryType* entry = &cache->cacheArr[set][way];
+			savedLineType line;
+			memset(&line, 0, sizeof(savedLineType));
+			line.dirtyBit = entry->dirtyBit;
+			line.validBit = entry->validBit;
+			line.tag = entry->tag;
+			line.lastUse = entry->lastUse;
+			ok = fwrite(&line, sizeof(savedLineType), 1, fp) == 1 &&
+				fwrite(entry->data, sizeof(int), cache->wordsPerBlock, fp) == (size_t)cache->wordsPerBlock;
+		}
+	}
+	return ok ? 0 : -1;
+}
+
+/*
+* Restore a state written by cacheWriteState from buffer into a cache configured
+* with the same geometry. buffer must hold cacheStateSize bytes. Returns the
+* first byte after the state.
+*/
+const char* cacheReadState(cacheType* cache, const char* buffer){
+	memcpy(&cache->useClock, buffer, sizeof(long long));
+	buffer += sizeof(long long);
+	memcpy(&cache->stats, buffer, sizeof(cacheStatsType));
+	buffer += sizeof(cacheStatsType);
+	for (int set = 0; set < cache->sets; set++ ){
+		for (int way = 0; way < cache->ways; way++ ){
+			cacheEntryType* entry = &cache->cacheArr[set][way];
+			savedLineType line;
+			memcpy(&line, buffer, sizeof(savedLineType));
+			buffer += sizeof(savedLineType);
+			entry->dirtyBit = (enum dirty_bit)line.dirtyBit;
+			entry->validBit = (enum valid_bit)line.validBit;
+			entry->tag = line.tag;
+			entry->lastUse = line.lastUse;
+			memcpy(entry->data, buffer, cache->wordsPerBlock * sizeof(int));
+			buffer += cache->wordsPerBlock * sizeof(int);
+		}
+	}
+	return buffer;
+}
+
+static int compareLastUse(const void* a, const void* b){
+	long long lastUseA = (*(cacheEntryType* const*)a)->lastUse;
+	long long lastUseB = (*(cacheEntryType* const*)b)->lastUse;
+	return (lastUseA > lastUseB) - (lastUseA < lastUseB);
+}
+
+/*
+* Warm a cache of any geometry with the contents of another cache over the same
+* memory. Dirty blocks of from are written back first, then the block holding
+* each valid line of from is brought into to, oldest first, so the most recently
+* filled blocks are the ones kept. Nothing is logged, from is left invalid
+* and to takes over the statistics of from, including the write backs made by
+* the transfer; the fills into to are not counted.
+*/
+void cacheTransfer(cacheType* to, cacheType* from){
+	int lines = 0;
+	cacheEntryType** order = (cacheEntryType**)malloc((size_t)from->sets * from->ways * sizeof(cacheEntryType*));
+	int* addresses = (int*)malloc((size_t)from->sets * from->ways * sizeof(int));
+	cacheLoggerType fromLogger = from->logger;
+	cacheLoggerType toLogger = to->logger;
+	from->logger = NULL;
+	to->logger = NULL;
+
+	for (int set = 0; set < from->sets; set++ ){
+		for (int way = 0; way < from->ways; way++ ){
+			if (from->cacheArr[set][way].validBit == valid){
+				order[lines++] = &from->cacheArr[set][way];
+			}
+		}
+	}
+	qsort(order, lines, sizeof(cacheEntryType*), compareLastUse);
+
+	for (int i = 0; i < lines; i++ ){
+		int set = (int)((order[i] - from->cacheArr[0]) / from->ways);
+		int way = (int)((order[i] - from->cacheArr[0]) % from->ways);
+		addresses[i] = buildAddress(order[i]->tag, set, 0, from);
+		cacheToMem(addresses[i], from, way);
+	}
+	cacheStatsType stats = from->stats;
+
+	for (int i = 0; i < lines; i++ ){
+		for (int word = 0; word < from->wordsPerBlock; word += to->wordsPerBlock ){
+			to->useClock++;
+			if (searchCache(addresses[i] + word, to) == -1){
+				memToCache(addresses[i] + word, to);
+			}
+		}
+	}
+	to->stats = stats;
+
+	from->logger = fromLogger;
+	to->logger = toLogger;
+	free(order);
+	free(addresses);
+}
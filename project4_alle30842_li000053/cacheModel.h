@@ -0,0 +1,108 @@
+#ifndef CACHEMODEL_H
+#define CACHEMODEL_H
+
+#include <stdio.h>
+
+// Enums
+enum dirty_bit {dirty, clean};
+enum valid_bit {valid, invalid};
+enum action_type {cache_to_processor, processor_to_cache, memory_to_cache, cache_to_memory,
+cache_to_nowhere};
+enum access_type {read_mem, write_mem, halt};
+enum hit_or_miss {hit, miss};
+
+// Structures
+typedef struct cacheEntryStruct {
+    enum dirty_bit dirtyBit;
+	enum valid_bit validBit;
+	int tag;
+	int *data;
+	long long lastUse; // value of useClock when the block was brought into the cache
+} cacheEntryType;
+
+// Running totals kept by the cache model
+typedef struct cacheStatsStruct {
+	long long accesses;
+	long long reads;
+	long long writes;
+	long long hits;
+	long long misses;
+	long long writeBacks; // dirty blocks written back to memory
+	long long evictions; // clean blocks thrown away
+} cacheStatsType;
+
+// One entry of a batched access
+typedef struct cacheRequestStruct {
+	int address;
+	enum access_type action;
+	int writeValue;
+} cacheRequestType;
+
+/*
+* Optional logger for block transfers. It receives the same arguments as
+* print_action in the simulator; when NULL the model is silent.
+*/
+typedef void (*cacheLoggerType)(int address, int size, enum action_type type);
+
+/*
+* Optional mapping from the address of a block's first word to where that block
+* lives in the backing memory, for caches accessed with virtual addresses. It is
+* only called when a block moves between the cache and memory, so it may keep
+* state such as a TLB. It must return the first word of a block inside memory;
+* when NULL blocks are stored at their own address.
+*/
+typedef int (*cacheTranslatorType)(void* context, int address);
+
+typedef struct cacheStruct {
+	cacheEntryType **cacheArr;
+	int sets;
+	int ways;
+	int wordsPerBlock;
+
+	// address decoding, derived from the geometry by cacheConfigure
+	int blkOffsetBits;
+	int setBits;
+	int blkOffsetMask;
+	int setMask;
+
+	// backing memory, owned by the caller
+	int *mem;
+	int numMemory;
+
+	long long useClock; // advanced once per access, used for replacement
+	cacheStatsType stats;
+	cacheLoggerType logger;
+	cacheTranslatorType translator;
+	void* translatorContext;
+} cacheType;
+
+// Life cycle
+cacheType* cacheCreate(void);
+int cacheConfigure(cacheType* cache, int wordsPerBlock, int sets, int ways, int* mem, int numMemory);
+void cacheDestroy(cacheType* cache);
+
+// Address helpers
+int getTag(int address, cacheType* cache);
+int getSet(int address, cacheType* cache);
+int getBlkOffset(int address, cacheType* cache);
+int getAddressBase(int address, cacheType* cache);
+int buildAddress(int tag, int set, int blockOffset, cacheType* cache);
+long long getCyclesSinceLastUse(cacheType* cache, int set, int way);
+
+// Cache operations
+int searchCache(int address, cacheType* cache);
+int alocateCacheLine(int address, cacheType* cache);
+int memToCache(int address, cacheType* cache);
+void cacheToMem(int address, cacheType* cache, int way);
+// cacheAccess aborts on an address outside of memory, cacheAccessBatch returns -1
+int cacheAccess(cacheType* cache, int address, enum access_type action, int write_value);
+int cacheAccessBatch(cacheType* cache, const cacheRequestType* requests, int count,
+	int* readValues, unsigned char* hitBitmap, cacheStatsType* stats);
+
+// Saving and restoring
+long cacheStateSize(cacheType* cache);
+int cacheWriteState(cacheType* cache, FILE* fp);
+const char* cacheReadState(cacheType* cache, const char* buffer);
+void cacheTransfer(cacheType* to, cacheType* from);
+
+#endif
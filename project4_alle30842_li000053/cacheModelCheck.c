@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "cacheModel.h"
+
+#define NUMMEMORY 64
+
+static int failures = 0;
+static int translations = 0;
+
+// keeps every block where it is, counting the calls
+static int countingTranslator(void* context, int address){
+	(void)context;
+	translations++;
+	return address;
+}
+
+static void expect(int condition, const char* what){
+	if (condition){
+		printf("PASS %s\n", what);
+	}
+	else{
+		printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+int main(void){
+	int mem[NUMMEMORY];
+	for (int i = 0; i < NUMMEMORY; i++ ){
+		mem[i] = 1000 + i;
+	}
+
+	cacheType* cache = cacheCreate();
+	expect(cacheConfigure(cache, 4, 2, 1, mem, NUMMEMORY - 2) == -1, "memory that is not a whole number of blocks is rejected");
+	expect(cacheConfigure(cache, 3, 2, 1, mem, NUMMEMORY) == -1, "block size that is not a power of two is rejected");
+	expect(cacheConfigure(cache, 4, 2, 1, mem, NUMMEMORY) == 0, "4.2.1 cache over 64 words is accepted");
+
+	// miss, hit, hit, write miss, write hit, read hit, miss in set 1, then two misses in set 0
+	cacheRequestType requests[] = {
+		{0, read_mem, 0},
+		{1, read_mem, 0},
+		{3, read_mem, 0},
+		{17, write_mem, 77},
+		{18, write_mem, 78},
+		{17, read_mem, 0},
+		{4, read_mem, 0},
+		{8, read_mem, 0},
+		{16, read_mem, 0},
+	};
+	int count = sizeof(requests) / sizeof(requests[0]);
+	int readValues[9];
+	unsigned char hitBitmap[2] = {0xFF, 0xFF};
+	cacheStatsType stats;
+
+	int hits = cacheAccessBatch(cache, requests, count, readValues, hitBitmap, &stats);
+	expect(hits == 4, "batch returns the number of hits");
+	expect(hitBitmap[0] == 0x36 && hitBitmap[1] == 0x00, "hit bitmap is LSB first and cleared for misses");
+	expect(readValues[0] == 1000 && readValues[1] == 1001 && readValues[2] == 1003 && readValues[6] == 1004,
+		"reads return memory contents");
+	expect(readValues[3] == -1 && readValues[4] == -1, "writes report -1 in readValues");
+	expect(readValues[5] == 77, "reads see earlier writes in the same batch");
+	expect(stats.accesses == 9 && stats.reads == 7 && stats.writes == 2 && stats.hits == 4 && stats.misses == 5,
+		"batch counters cover the batch");
+	expect(stats.writeBacks == 1 && stats.evictions == 2, "batch counts write backs and evictions");
+	expect(mem[17] == 77 && mem[18] == 78 && readValues[8] == 1016, "evicted dirty block is written back");
+
+	cacheRequestType again[] = {{16, read_mem, 0}, {0, write_mem, 5}};
+	hits = cacheAccessBatch(cache, again, 2, NULL, NULL, &stats);
+	expect(hits == 1 && stats.accesses == 2 && stats.hits == 1, "second batch counters start from zero");
+	expect(cache->stats.accesses == 11 && cache->stats.hits == 5, "running totals cover every batch");
+
+	cacheRequestType outside[] = {{0, read_mem, 0}, {NUMMEMORY, read_mem, 0}};
+	cacheStatsType before = cache->stats;
+	expect(cacheAccessBatch(cache, outside, 2, NULL, NULL, NULL) == -1, "address past memory is rejected");
+	outside[1].address = -1;
+	expect(cacheAccessBatch(cache, outside, 2, NULL, NULL, NULL) == -1, "negative address is rejected");
+	expect(memcmp(&before, &cache->stats, sizeof(cacheStatsType)) == 0, "rejected batch does not touch the cache");
+
+	cache->translator = countingTranslator;
+	cacheRequestType translated[] = {{0, read_mem, 0}, {1, read_mem, 0}, {2, read_mem, 0}, {32, read_mem, 0}};
+	translations = 0;
+	expect(cacheAccessBatch(cache, translated, 4, NULL, NULL, NULL) == 3 && translations == 2,
+		"translator is only called for the fill and the write back");
+	cache->translator = NULL;
+
+	cacheRequestType flush[] = {{0, halt, 0}};
+	hitBitmap[0] = 0xFF;
+	expect(cacheAccessBatch(cache, flush, 1, NULL, hitBitmap, NULL) == 0 && hitBitmap[0] == 0, "halt is not a hit");
+	expect(mem[0] == 5, "halt writes dirty blocks back");
+
+	// two dirty blocks warmed into a one word cache are written back and counted once
+	cacheRequestType dirtying[] = {{4, write_mem, 44}, {40, write_mem, 40}};
+	cacheAccessBatch(cache, dirtying, 2, NULL, NULL, NULL);
+	cacheStatsType saved = cache->stats;
+	cacheType* warmed = cacheCreate();
+	cacheConfigure(warmed, 1, 1, 1, mem, NUMMEMORY);
+	cacheTransfer(warmed, cache);
+	expect(mem[4] == 44 && mem[40] == 40, "transfer writes dirty blocks back");
+	expect(warmed->stats.writeBacks == saved.writeBacks + 2 && warmed->stats.accesses == saved.accesses &&
+		warmed->stats.misses == saved.misses, "transfer counts its write backs but not its fills");
+	cacheDestroy(warmed);
+
+	cacheDestroy(cache);
+	return failures == 0 ? 0 : 1;
+}
@@ -1,10 +1,16 @@
 #include <errno.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
-#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cacheModel.h"
 
 #define NUMMEMORY 65536 /* maximum number of data words in memory */
 #define NUMREGS 8 /* number of machine registers */
@@ -20,56 +26,90 @@
 
 #define NOOPINSTRUCTION 0x1c00000
 
-// Enums
-enum dirty_bit {dirty, clean};
-enum valid_bit {valid, invalid};
-enum action_type {cache_to_processor, processor_to_cache, memory_to_cache, cache_to_memory,
-cache_to_nowhere};
-enum access_type {read_mem, write_mem, halt};
-enum hit_or_miss {hit, miss};
-
-// Structures
-typedef struct cacheEntryStruct {
-    enum dirty_bit dirtyBit;
-	enum valid_bit validBit;
-	int tag;
-	int *data;
-	int cyclesSinceLastUse;
-} cacheEntryType;
+#define CACHEHITCYCLES 1 /* cost of a page table reference that hits in the cache */
+#define MEMORYCYCLES 100 /* cost of a page table reference that goes to memory */
+
+#define CHECKPOINTMAGIC "LC2KCKPT"
+#define CHECKPOINTVERSION 2
+#define CHUNKWORDS 256 /* memory is saved in chunks of this many words, all zero chunks are skipped */
+
+typedef struct vmStruct {
+	int pageSize;
+	int pageBits;
+	int numPages; // virtual pages, one page table entry each
+	int ptBase; // physical address of the page table
+	int virtualIndexFlag; // cache is accessed with virtual rather than physical addresses
+	cacheType *tlb; // one word blocks holding page table entries, addressed by page number
+	long long walkCycles;
+	int *pendingWalks; // pages whose walk waits for the cache access that needed it to finish
+	int numPendingWalks;
+} vmType;
 
 typedef struct stateStruct {
     int pc;
 	int mem[NUMMEMORY];
 	int reg[NUMREGS];
 	int numMemory;
-	cacheEntryType **cacheArr;
-	int sets;
-	int ways;
-	int wordsPerBlock;
+	cacheType *cache;
+	vmType *vm; // NULL when addresses are not translated
 	int discriptiveFlag;
+	int quietFlag;
+	long long totalInstrs; // instructions executed before run() starts, non zero after a restore
+	long long checkpointAt; // instruction count to checkpoint at, -1 for none
+	char* checkpointFile;
 } stateType;
 
+/*
+* Start of a checkpoint file. It is followed by the cache state, the TLB state
+* when pageSize is not 0, and numChunks memory chunks each made of its chunk
+* index followed by CHUNKWORDS words.
+*/
+typedef struct checkpointHeaderStruct {
+	char magic[8];
+	int version;
+	int pc;
+	int reg[NUMREGS];
+	int numMemory;
+	long long totalInstrs;
+	int wordsPerBlock;
+	int sets;
+	int ways;
+	int pageSize;
+	int tlbSets;
+	int tlbWays;
+	int virtualIndexFlag;
+	int numChunks;
+	long long walkCycles;
+} checkpointHeaderType;
+
+// Set from the SIGUSR1 handler, the only state that can not live in stateType
+static volatile sig_atomic_t checkpointRequested = 0;
+
 // Function Headers
 int field0(int instruction);
 int field1(int instruction);
 int field2(int instruction);
 int opcode(int instruction);
-int getTag(int address, stateType* state);
-int getSet(int address, stateType* state);
-int getBlkOffset(int address, stateType* state);
-int searchCache(int address, stateType* state);
-int alocateCacheLine(int address, stateType* state);
 int cacheSystem(int address, stateType* state, enum access_type action, int write_value);
+int translate(int address, stateType* state);
+int pageTableWalk(int page, stateType* state);
+int mapAddress(int address, stateType* state);
+void checkAddress(int address, stateType* state);
+void runPendingWalks(stateType* state);
+int physicalBlockAddress(void* context, int address);
+int mappedBlockAddress(void* context, int address);
+int initVirtualMemory(stateType* state, int pageSize, int tlbSets, int tlbWays, int virtualIndexFlag);
+void print_vm_stats(stateType* state);
+void requestCheckpoint(int signum);
+int chunkIsTouched(stateType* state, int chunk);
+int writeCheckpoint(stateType* state, long long total_instrs);
+int restoreCheckpoint(stateType* state, const char* buffer, long size);
 int signExtend(int num);
 void run(stateType* state);
 void print_action(int address, int size, enum action_type type);
 void printCache(stateType* state);
-void incrementCyclesSinceLastUse(stateType* state);
-int memToCache(int address, stateType* state);
-void cacheToMem(int address, stateType* state, int way);
-int getAddressBase(int address, stateType* state);
+void print_stats(long long total_instrs, double seconds, stateType* state);
 void printInstruction(int instr);
-int buildAddress(int tag, int set, int blockOffset, stateType* state);
 
 // Functions
 char* getDirtyBitName(enum dirty_bit bit) 
@@ -138,87 +178,6 @@ int opcode(int instruction){
     return(instruction>>22);
 }
 
-int getTag(int address, stateType* state){
-	int words_per_blk = state->wordsPerBlock;
-	int num_of_set = state->sets;
-
-	//to get the number of bits to represent set and the number of bits to represent block offset
-	int bits_blkOffset = log(words_per_blk)/log(2);
-	int bits_set = log(num_of_set)/log(2);
-
-	//cut all the bits which represent the set number and block offset.
-	int tag = address >> (bits_blkOffset + bits_set);
-
-	return tag;
-}
-
-int getSet(int address, stateType* state){
-
-	//to get the number of bits to represent set
-	int num_of_set = state->sets;
-	int bits_needed = log(num_of_set) / log(2);
-	int mask = 0;
-
-	//to get the number of bits to represent block offset
-	int words_per_blk = state->wordsPerBlock;
-	int blkOffset_bits_needed = log(words_per_blk) / log(2);
-
-	//to build the mask for getting corresponding bits for set in given address
-	for(int i=0; i<bits_needed ;i++){
-		mask += pow(2,i);
-	}
-
-	//cut all block offset based on the number of bits to represent the block offset
-	int set = address >> blkOffset_bits_needed;
-
-	//masking
-	set = (set & mask);
-
-	return set;
-}
-
-int getBlkOffset(int address, stateType* state){
-	int words_per_blk = state->wordsPerBlock;
-	int bits_needed = log(words_per_blk) / log(2);
-	int mask = 0;
-
-	for(int i=0; i<bits_needed ;i++){
-		mask += pow(2,i);
-	}
-
-	int offset = (address & mask);
-
-	return offset;
-}
-
-//get the base address based on the given address
-int getAddressBase(int address, stateType* state){
-	int words_per_blk = state->wordsPerBlock;
-	int bits_needed = log(words_per_blk) / log(2);
-	int mask = 0;
-
-	for(int i=0; i<bits_needed ;i++){
-		mask += pow(2,i);
-	}
-	int baseAddress = (address & (~mask));
-
-	return baseAddress;
-}
-
-//build back the address based on tag, set, and block offset
-int buildAddress(int tag, int set, int blockOffset, stateType* state){
-	int blkOffsetBits = log(state->wordsPerBlock) / log(2);
-	int setBits = log(state->sets) / log(2);
-
-	//left shift every element in correct position
-	tag = tag << (setBits + blkOffsetBits);
-	set = set << blkOffsetBits;
-
-	int address = tag | set | blockOffset;
-
-	return address;
-}
-
 void printInstruction(int instr){
     char opcodeString[10];
     if (opcode(instr) == ADD) {
@@ -275,22 +234,22 @@ void print_action(int address, int size, enum action_type type){
 
 void printCache(stateType* state){
 	if(state->discriptiveFlag == 1){
+		cacheType* cache = state->cache;
 		// loop through all sets of cache
 		printf("\nCache Contents:\n");
-		for (int i = 0; i < state->sets; i++ ){
+		for (int i = 0; i < cache->sets; i++ ){
 			printf("Set: %d\n", i);
 			// loop through all the ways of a set
-			for (int k = 0; k < state->ways; k++ ){
+			for (int k = 0; k < cache->ways; k++ ){
 				printf("Way: %d\n", k);
-				printf("tag: %d\n", state->cacheArr[i][k].tag);
-				printf("cyclesSinceLastUse: %d\n", state->cacheArr[i][k].cyclesSinceLastUse);
-				printf("dirtyBit: %s\n", getDirtyBitName(state->cacheArr[i][k].dirtyBit));
-				printf("validBit: %s\n", getValidBitName(state->cacheArr[i][k].validBit));
+				printf("tag: %d\n", cache->cacheArr[i][k].tag);
+				printf("cyclesSinceLastUse: %lld\n", getCyclesSinceLastUse(cache, i, k));
+				printf("dirtyBit: %s\n", getDirtyBitName(cache->cacheArr[i][k].dirtyBit));
+				printf("validBit: %s\n", getValidBitName(cache->cacheArr[i][k].validBit));
 				printf("data:\t");
-				for (int l = 0; l < state->wordsPerBlock; l++ ){
-					printf("%d", state->cacheArr[i][k].data[l]); 
-					// printf("%p",(void *)&state->cacheArr[i][k].data[l]); 
-					if (l != state->wordsPerBlock-1){
+				for (int l = 0; l < cache->wordsPerBlock; l++ ){
+					printf("%d", cache->cacheArr[i][k].data[l]); 
+					if (l != cache->wordsPerBlock-1){
 						printf(" | "); 
 					}
 				}
@@ -301,187 +260,356 @@ void printCache(stateType* state){
 	}
 }
 
-// return >= 0 way contaning the address if the given address is in cache otherwise -1
-int searchCache(int address, stateType* state){
-	int set = getSet(address, state);
-	int tag = getTag(address, state);
-	// loop through all the ways of the address's set
-	for (int way = 0; way < state->ways; way++ ){
-		// if the tag is found in the set return 1
-		if (state->cacheArr[set][way].validBit == valid && state->cacheArr[set][way].tag == tag){
-			return way;
-		}
-	}	
-	// otherwise return -1
-	return -1;
+// Print the totals for a run, used in place of the per-access log by -q
+// seconds is the time spent in the run loop, without loading the program
+void print_stats(long long total_instrs, double seconds, stateType* state){
+	cacheStatsType* stats = &state->cache->stats;
+	printf("instructions: %lld\n", total_instrs);
+	printf("seconds: %.6f\n", seconds);
+	printf("accesses: %lld\n", stats->accesses);
+	printf("hits: %lld\n", stats->hits);
+	printf("misses: %lld\n", stats->misses);
+	printf("writeBacks: %lld\n", stats->writeBacks);
+	printf("evictions: %lld\n", stats->evictions);
 }
 
-// Returns the way in the cach set corisponding to the given address that can be overwriten
-int alocateCacheLine(int address, stateType* state){
-	int set = getSet(address, state);
-	int lru = 0;
-	// loop through all the ways of a set
-	for (int way = 0; way < state->ways; way++ ){
-		// If the current way is invalid return it to be overwriten
-		if (state->cacheArr[set][way].validBit == invalid){
-			return way;
-		}
-		// If the current line's cyclesSinceLastUse is greater than the current 
-		// lru's cyclesSinceLastUse change the lru to the current way
-		if (state->cacheArr[set][way].cyclesSinceLastUse > state->cacheArr[set][lru].cyclesSinceLastUse){
-			lru = way;
-		}
-	}	
-	// check if the lru way needs to be written back to memory
-	int lruAddress = buildAddress(state->cacheArr[set][lru].tag, set, 0, state);
-	if (state->cacheArr[set][lru].dirtyBit == dirty){
-		cacheToMem(lruAddress, state, lru);
+/*
+* Build the page table and TLB for a virtual address space in front of the cache.
+*
+* The page table sits in the top frames of physical memory with one entry per
+* virtual page holding its frame number. Virtual pages are mapped to frames from
+* the top of the remaining memory down so that translation is never the identity.
+* Prints the reason and returns -1 on a bad page size or TLB geometry.
+*/
+int initVirtualMemory(stateType* state, int pageSize, int tlbSets, int tlbWays, int virtualIndexFlag){
+	if (pageSize < state->cache->wordsPerBlock || pageSize > NUMMEMORY / 2 || (pageSize & (pageSize - 1)) != 0){
+		printf("Invalid virtual memory: -p must be a power of two between -b and %d\n", NUMMEMORY / 2);
+		return -1;
 	}
-	else{
-		state->cacheArr[set][lru].validBit = invalid;
-		print_action(getAddressBase(lruAddress, state), state->wordsPerBlock, cache_to_nowhere);
+	int numFrames = NUMMEMORY / pageSize;
+	int ptFrames = (numFrames + pageSize - 1) / pageSize;
+	if (numFrames - ptFrames <= 0){
+		printf("Invalid virtual memory: with -p %d the page table fills all of memory\n", pageSize);
+		return -1;
 	}
-	return lru;
-}
 
-// increment the cyclesSinceLastUse for all items in cache
-void incrementCyclesSinceLastUse(stateType* state){
-	// loop through all sets of cache
-	for (int set = 0; set < state->sets; set++ ){
-		// loop through all the ways of a set
-		for (int way = 0; way < state->ways; way++ ){
-			state->cacheArr[set][way].cyclesSinceLastUse = state->cacheArr[set][way].cyclesSinceLastUse + 1;
-		}
+	vmType* vm = (vmType*)malloc(sizeof(vmType));
+	vm->pageSize = pageSize;
+	vm->pageBits = 0;
+	while ((1 << vm->pageBits) < pageSize){
+		vm->pageBits++;
+	}
+	vm->numPages = numFrames - ptFrames;
+	vm->ptBase = vm->numPages * pageSize;
+	vm->virtualIndexFlag = virtualIndexFlag;
+	vm->walkCycles = 0;
+	// each fill and write back of one access, or each write back of a halt, can need a walk
+	vm->pendingWalks = (int*)malloc(((size_t)state->cache->sets * state->cache->ways + 2) * sizeof(int));
+	vm->numPendingWalks = 0;
+
+	for (int page = 0; page < vm->numPages; page++ ){
+		state->mem[vm->ptBase + page] = vm->numPages - 1 - page;
+	}
+
+	// the TLB caches page table entries straight out of the page table
+	vm->tlb = cacheCreate();
+	if (vm->tlb == NULL ||
+		cacheConfigure(vm->tlb, 1, tlbSets, tlbWays, &state->mem[vm->ptBase], vm->numPages) != 0){
+		printf("Invalid virtual memory: -t and -w must be powers of two\n");
+		cacheDestroy(vm->tlb);
+		free(vm->pendingWalks);
+		free(vm);
+		return -1;
 	}
+
+	// a virtually indexed cache only translates when a block moves to or from memory
+	if (virtualIndexFlag == 1){
+		state->cache->translator = physicalBlockAddress;
+		state->cache->translatorContext = state;
+	}
+
+	state->vm = vm;
+	return 0;
 }
 
-int memToCache(int address, stateType* state){
-	int tag = getTag(address, state);
-	int set = getSet(address, state);
-	int blkOffset = getBlkOffset(address, state);
+// Read the page table entry for page through the cache and charge its cycles to the walk
+int pageTableWalk(int page, stateType* state){
+	vmType* vm = state->vm;
+	long long hitsBefore = state->cache->stats.hits;
 
-	//find the available way in the set to write
-	int way_to_write = alocateCacheLine(address, state);
+	int frame = cacheAccess(state->cache, vm->ptBase + page, read_mem, -1);
+	if (state->cache->stats.hits != hitsBefore){
+		vm->walkCycles += CACHEHITCYCLES;
+	}
+	else{
+		vm->walkCycles += MEMORYCYCLES;
+	}
+	return frame;
+}
 
-	//overwrite the the way with the new data from mem
-	state->cacheArr[set][way_to_write].dirtyBit = clean;
-	state->cacheArr[set][way_to_write].validBit = valid;
-	state->cacheArr[set][way_to_write].tag = tag;
-	state->cacheArr[set][way_to_write].cyclesSinceLastUse = 0;
+void checkAddress(int address, stateType* state){
+	if (address < 0 || (address >> state->vm->pageBits) >= state->vm->numPages){
+		printf("Virtual address %d is outside of the address space\n", address);
+		exit(1);
+	}
+}
 
-	for(int i=0; i<state->wordsPerBlock; i++){
-		state->cacheArr[set][way_to_write].data[i] = state->mem[getAddressBase(address, state) + i];
+/*
+* Translate a virtual word address through the TLB, walking the page table on a miss.
+*
+* A virtually indexed cache translates from inside a fill or write back, where
+* the walk can not use the cache yet. Its walks are queued for runPendingWalks
+* and the TLB is filled from the page table, which programs can never write.
+*/
+int translate(int address, stateType* state){
+	vmType* vm = state->vm;
+	int page = address >> vm->pageBits;
+	checkAddress(address, state);
+
+	long long hitsBefore = vm->tlb->stats.hits;
+	int frame = cacheAccess(vm->tlb, page, read_mem, -1);
+	if (vm->tlb->stats.hits == hitsBefore){
+		if (vm->virtualIndexFlag == 1){
+			vm->pendingWalks[vm->numPendingWalks++] = page;
+		}
+		else{
+			// the entry now in the TLB must match what the walk read through the cache
+			frame = pageTableWalk(page, state);
+			vm->tlb->cacheArr[getSet(page, vm->tlb)][searchCache(page, vm->tlb)].data[0] = frame;
+		}
 	}
+	return (frame << vm->pageBits) | (address & (vm->pageSize - 1));
+}
 
-	print_action(getAddressBase(address, state), state->wordsPerBlock, memory_to_cache);
-	return way_to_write;
+/*
+* Make the page table references queued by translate. A walk can evict a dirty
+* block whose write back queues another walk, so the queue never grows.
+*/
+void runPendingWalks(stateType* state){
+	vmType* vm = state->vm;
+	while (vm->numPendingWalks > 0){
+		vm->numPendingWalks--;
+		pageTableWalk(vm->pendingWalks[vm->numPendingWalks], state);
+	}
 }
 
-void cacheToMem(int address, stateType* state, int way){
-	int tag = getTag(address, state);
-	int set = getSet(address, state);
-	int blkOffset = getBlkOffset(address, state);
+// Map a virtual address with the page table in memory, without touching the TLB or the cache
+int mapAddress(int address, stateType* state){
+	vmType* vm = state->vm;
+	int page = address >> vm->pageBits;
+	return (state->mem[vm->ptBase + page] << vm->pageBits) | (address & (vm->pageSize - 1));
+}
 
-	// check if the way_to_write way needs to be written back to memory (is dirty)
-	if (state->cacheArr[set][way].dirtyBit == dirty){
-		// write each word in the block to memory
-		for (int word = 0; word < state->wordsPerBlock; word++ ){
-			state->mem[getAddressBase(address, state) + word] = state->cacheArr[set][way].data[word];
-		}	
-		print_action(getAddressBase(address, state), state->wordsPerBlock, cache_to_memory);
+/*
+* Translator installed on a virtually indexed cache, called for every fill and
+* write back. Page table addresses lie above every virtual address and are left
+* as they are; anything else goes through the TLB.
+*/
+int physicalBlockAddress(void* context, int address){
+	stateType* state = (stateType*)context;
+	if (address >= state->vm->ptBase){
+		return address;
 	}
-	else{
-		printf("tried to move cach to mem but no dirty data found, tried to do: ");
-		print_action(getAddressBase(address, state), state->wordsPerBlock, cache_to_memory);
+	return translate(address, state);
+}
+
+/*
+* Translator used while a restore warms a virtually indexed cache. It maps with
+* the page table alone, so the transfer neither touches the TLB, whose saved
+* state is restored afterwards, nor queues walks for an access that never ran.
+*/
+int mappedBlockAddress(void* context, int address){
+	stateType* state = (stateType*)context;
+	if (address >= state->vm->ptBase){
+		return address;
 	}
-	// make cache entry invalid
-	state->cacheArr[set][way].validBit = invalid;
+	return mapAddress(address, state);
 }
 
+void print_vm_stats(stateType* state){
+	cacheStatsType* stats = &state->vm->tlb->stats;
+	printf("tlb hits: %lld\n", stats->hits);
+	printf("tlb misses: %lld\n", stats->misses);
+	printf("tlb hit rate: %.2f%%\n", stats->accesses > 0 ? 100.0 * stats->hits / stats->accesses : 0.0);
+	printf("page walks: %lld\n", stats->misses);
+	printf("walk cycles: %lld\n", state->vm->walkCycles);
+}
 
-	// * address is the starting word address of the range of data being transferred.
-	// * size is the size of the range of data being transferred.
-	// * type specifies the source and destination of the data being transferred.
-	// *
-	// * cache_to_processor: reading data from the cache to the processor
-	// * processor_to_cache: writing data from the processor to the cache
-	// * memory_to_cache: reading data from the memory to the cache
-	// * cache_to_memory: evicting cache data by writing it to the memory
-	// * cache_to_nowhere: evicting cache data by throwing it away
-	// */
-	// print_action(address, 1, action_type);
-	// print_action(address, state->wordsPerBlock, cache_to_nowhere);
+void requestCheckpoint(int signum){
+	(void)signum;
+	checkpointRequested = 1;
+}
 
-int cacheSystem(int address, stateType* state, enum access_type action, int write_value){
-	incrementCyclesSinceLastUse(state);
+// return 1 if any word of the chunk is not zero, chunks never written are all zero
+int chunkIsTouched(stateType* state, int chunk){
+	int* words = &state->mem[chunk * CHUNKWORDS];
+	for (int word = 0; word < CHUNKWORDS; word++ ){
+		if (words[word] != 0){
+			return 1;
+		}
+	}
+	return 0;
+}
 
-	int tag = getTag(address, state);
-	int set = getSet(address, state);
-	int blkOffset = getBlkOffset(address, state);
+/*
+* Save everything needed to resume the run at instruction total_instrs to
+* state->checkpointFile. Returns 0 on success and -1 if the file can not be written.
+*/
+int writeCheckpoint(stateType* state, long long total_instrs){
+	FILE* fp = fopen(state->checkpointFile, "wb");
+	if (fp == NULL){
+		fprintf(stderr, "Cannot open file '%s' : %s\n", state->checkpointFile, strerror(errno));
+		return -1;
+	}
 
-	int whereInCache = searchCache(address, state);
+	checkpointHeaderType header;
+	memset(&header, 0, sizeof(checkpointHeaderType));
+	memcpy(header.magic, CHECKPOINTMAGIC, sizeof(header.magic));
+	header.version = CHECKPOINTVERSION;
+	header.pc = state->pc;
+	memcpy(header.reg, state->reg, sizeof(header.reg));
+	header.numMemory = state->numMemory;
+	header.totalInstrs = total_instrs;
+	header.wordsPerBlock = state->cache->wordsPerBlock;
+	header.sets = state->cache->sets;
+	header.ways = state->cache->ways;
+	if (state->vm != NULL){
+		header.pageSize = state->vm->pageSize;
+		header.tlbSets = state->vm->tlb->sets;
+		header.tlbWays = state->vm->tlb->ways;
+		header.virtualIndexFlag = state->vm->virtualIndexFlag;
+		header.walkCycles = state->vm->walkCycles;
+	}
+	for (int chunk = 0; chunk < NUMMEMORY / CHUNKWORDS; chunk++ ){
+		header.numChunks += chunkIsTouched(state, chunk);
+	}
 
-	//processor read from mem
-	if(action == read_mem){
-		int readValue;
-		// hit
-		if(isHittOrMiss(whereInCache) == hit){
-			// read hit
-			readValue = state->cacheArr[set][whereInCache].data[blkOffset];
-		}
-		// miss
-		else{
-			// read miss
-			int blockWay = memToCache(address, state);
-			readValue = state->cacheArr[set][blockWay].data[blkOffset];
+	int ok = fwrite(&header, sizeof(checkpointHeaderType), 1, fp) == 1;
+	ok = ok && cacheWriteState(state->cache, fp) == 0;
+	if (state->vm != NULL){
+		ok = ok && cacheWriteState(state->vm->tlb, fp) == 0;
+	}
+	for (int chunk = 0; chunk < NUMMEMORY / CHUNKWORDS && ok; chunk++ ){
+		if (chunkIsTouched(state, chunk)){
+			ok = fwrite(&chunk, sizeof(int), 1, fp) == 1 &&
+				fwrite(&state->mem[chunk * CHUNKWORDS], sizeof(int), CHUNKWORDS, fp) == CHUNKWORDS;
 		}
-		printCache(state);
-		print_action(address, 1, cache_to_processor);
-		return readValue;
 	}
+	if (fclose(fp) != 0 || !ok){
+		fprintf(stderr, "Error writing checkpoint '%s'\n", state->checkpointFile);
+		return -1;
+	}
+	fprintf(stderr, "checkpoint written to %s at instruction %lld\n", state->checkpointFile, total_instrs);
+	return 0;
+}
 
-	//process write to mem
-	else if(action == write_mem){
-		if(isHittOrMiss(whereInCache) == hit){
-			// write hit
-			state->cacheArr[set][whereInCache].data[blkOffset] = write_value;
-			state->cacheArr[set][whereInCache].dirtyBit = dirty;
+/*
+* Restore a checkpoint mapped at buffer into a state whose cache and virtual
+* memory are already set up. When the cache geometry differs from the one in the
+* checkpoint the saved cache is written back and its blocks are used to warm the
+* new cache instead. Returns 0 on success and -1 if the checkpoint is malformed.
+*/
+int restoreCheckpoint(stateType* state, const char* buffer, long size){
+	const checkpointHeaderType* header = (const checkpointHeaderType*)buffer;
+
+	// rebuild the cache the checkpoint was taken with over the same memory
+	cacheType* saved = state->cache;
+	int transfer = header->wordsPerBlock != state->cache->wordsPerBlock ||
+		header->sets != state->cache->sets || header->ways != state->cache->ways;
+	if (transfer){
+		saved = cacheCreate();
+		if (saved == NULL ||
+			cacheConfigure(saved, header->wordsPerBlock, header->sets, header->ways, state->mem, NUMMEMORY) != 0){
+			cacheDestroy(saved);
+			return -1;
 		}
-		else{
-			// write miss
-			int blockWay = memToCache(address, state);
-			state->cacheArr[set][blockWay].data[blkOffset] = write_value;
-			state->cacheArr[set][blockWay].dirtyBit = dirty;
+		if (state->cache->translator != NULL){
+			saved->translator = mappedBlockAddress;
+			saved->translatorContext = state;
+		}
+	}
+
+	const char* cacheState = buffer + sizeof(checkpointHeaderType);
+	const char* tlbState = cacheState + cacheStateSize(saved);
+	const char* chunks = tlbState + (state->vm != NULL ? cacheStateSize(state->vm->tlb) : 0);
+	long chunkSize = (1 + CHUNKWORDS) * sizeof(int);
+	if (header->numChunks < 0 || chunks + header->numChunks * chunkSize > buffer + size){
+		if (transfer){
+			cacheDestroy(saved);
 		}
-		printCache(state);
-		print_action(address, 1, processor_to_cache);
 		return -1;
 	}
 
-	else if (action == halt){
-		// loop through all sets of cache
-		for (int set = 0; set < state->sets; set++ ){
-			// loop through all the ways of a set
-			for (int way = 0; way < state->ways; way++ ){
-				// if the way contains valid dirty data make its address and write that block to memory
-				if(state->cacheArr[set][way].validBit == valid && state->cacheArr[set][way].dirtyBit == dirty){
-					int moveAddress = buildAddress(state->cacheArr[set][way].tag, set, 0, state);
-					cacheToMem(moveAddress, state, way);
-				}
-				// invalidate all cache lines
-				state->cacheArr[set][way].validBit = invalid;
+	// memory first so that a transfer writes the saved cache back over it
+	for (int i = 0; i < header->numChunks; i++ ){
+		int chunk;
+		memcpy(&chunk, chunks + i * chunkSize, sizeof(int));
+		if (chunk < 0 || chunk >= NUMMEMORY / CHUNKWORDS){
+			if (transfer){
+				cacheDestroy(saved);
 			}
+			return -1;
 		}
-		printCache(state);
+		memcpy(&state->mem[chunk * CHUNKWORDS], chunks + i * chunkSize + sizeof(int), CHUNKWORDS * sizeof(int));
 	}
 
-	else{
-		printCache(state);
-		printf("Error in cache access enum\n");
-		abort();
+	cacheReadState(saved, cacheState);
+	if (transfer){
+		cacheTranslatorType translator = state->cache->translator;
+		if (translator != NULL){
+			state->cache->translator = mappedBlockAddress;
+		}
+		cacheTransfer(state->cache, saved);
+		state->cache->translator = translator;
+		cacheDestroy(saved);
+	}
+	if (state->vm != NULL){
+		cacheReadState(state->vm->tlb, tlbState);
+		state->vm->walkCycles = header->walkCycles;
+	}
+
+	state->pc = header->pc;
+	memcpy(state->reg, header->reg, sizeof(state->reg));
+	state->numMemory = header->numMemory;
+	state->totalInstrs = header->totalInstrs;
+	return 0;
+}
+
+int cacheSystem(int address, stateType* state, enum access_type action, int write_value){
+	// the processor only sees virtual addresses when virtual memory is on,
+	// a virtually indexed cache translates them itself on a miss
+	int cacheAddress = address;
+	if (state->vm != NULL && action != halt){
+		if (state->vm->virtualIndexFlag == 0){
+			cacheAddress = translate(address, state);
+		}
+		else{
+			checkAddress(address, state);
+		}
+	}
+
+	int value = cacheAccess(state->cache, cacheAddress, action, write_value);
+	if (state->vm != NULL && action == halt){
+		// halt has flushed the cache, so the walks of its write backs read the page table from memory
+		// without filling the cache again
+		state->vm->walkCycles += MEMORYCYCLES * state->vm->numPendingWalks;
+		state->vm->numPendingWalks = 0;
+	}
+	else if (state->vm != NULL){
+		runPendingWalks(state);
 	}
 
-	return -1;
+	printCache(state);
+	if(state->quietFlag == 1){
+		return value;
+	}
+	if(action == read_mem){
+		print_action(address, 1, cache_to_processor);
+	}
+	else if(action == write_mem){
+		print_action(address, 1, processor_to_cache);
+	}
+	return value;
 }
 
 int signExtend(int num){
@@ -502,10 +630,19 @@ void run(stateType* state){
 	int branchTarget = 0;
 	int aluResult = 0;
 
-	int total_instrs = 0;
+	long long total_instrs = state->totalInstrs;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
 	// Primary loop
     while(1){
+		// Checkpoint before the next instruction so a restore resumes right here
+		if (total_instrs == state->checkpointAt || checkpointRequested){
+			checkpointRequested = 0;
+			writeCheckpoint(state, total_instrs);
+		}
+
 		total_instrs++;
 
 		//printState(state);
@@ -514,7 +651,7 @@ void run(stateType* state){
 		// instr = state->mem[state->pc];
 		instr = cacheSystem(state->pc, state, read_mem, -1);
 
-		if (state->discriptiveFlag == 1 || 1){
+		if (state->quietFlag == 0){
 			printInstruction(instr);
 		}
 
@@ -522,6 +659,9 @@ void run(stateType* state){
 		if (opcode(instr) == HALT) {
 			cacheSystem(state->pc, state, halt, -1);
 		    printf("machine halted\n");
+			if (state->vm != NULL){
+				print_vm_stats(state);
+			}
 			break;
 		}
 
@@ -593,27 +733,41 @@ void run(stateType* state){
 			}
 		}	
     } // While
-	// print_stats(total_instrs);
+	if (state->quietFlag == 1){
+		struct timespec end;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		print_stats(total_instrs, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, state);
+	}
 }
 
 int main(int argc, char** argv){
 
 	/** Get command line arguments **/
-    char* fname;
+    char* fname = NULL;
 
 	opterr = 0;
 
 	int cin = 0;
-	int blockSizeInWords;
-	int numSets;
-	int associativity;
+	int blockSizeInWords = 0;
+	int numSets = 0;
+	int associativity = 0;
 	int discriptiveFlag = 0;
-
-	while((cin = getopt(argc, argv, "f:b:s:a:d")) != -1){
+	int quietFlag = 0;
+	int pageSize = 0;
+	int tlbSets = 4;
+	int tlbWays = 2;
+	int virtualIndexFlag = 0;
+	long long checkpointAt = -1;
+	char* checkpointFile = "cacheSim.ckpt";
+	char* restoreFile = NULL;
+	int transferFlag = 0;
+	int vmOptionFlag = 0; // any of -p, -t, -w or -v was given
+
+	while((cin = getopt(argc, argv, "f:b:s:a:dqp:t:w:vc:o:r:T")) != -1){
 		switch(cin)
 		{
 			case 'f':
-				fname=(char*)malloc(strlen(optarg));
+				fname=(char*)malloc(strlen(optarg)+1);
 				fname[0] = '\0';
 				strncpy(fname, optarg, strlen(optarg)+1);
 				break;
@@ -631,6 +785,37 @@ int main(int argc, char** argv){
 				printf("Got discriptiveFlag!");
 				discriptiveFlag = 1;
 				break;
+			case 'q':
+				quietFlag = 1;
+				break;
+			case 'p':
+				pageSize = atoi(optarg);
+				vmOptionFlag = 1;
+				break;
+			case 't':
+				tlbSets = atoi(optarg);
+				vmOptionFlag = 1;
+				break;
+			case 'w':
+				tlbWays = atoi(optarg);
+				vmOptionFlag = 1;
+				break;
+			case 'v':
+				virtualIndexFlag = 1;
+				vmOptionFlag = 1;
+				break;
+			case 'c':
+				checkpointAt = atoll(optarg);
+				break;
+			case 'o':
+				checkpointFile = optarg;
+				break;
+			case 'r':
+				restoreFile = optarg;
+				break;
+			case 'T':
+				transferFlag = 1;
+				break;
 			case '?':
 				if(optopt == 'f'){
 					printf("Option -%c requires an argument.\n", optopt);
@@ -649,58 +834,109 @@ int main(int argc, char** argv){
 		}
 	}
 
+	/** Map the checkpoint to restore, it decides the geometry unless told otherwise **/
+	const char* checkpoint = NULL;
+	long checkpointSize = 0;
+	if (restoreFile != NULL){
+		if (fname != NULL || vmOptionFlag == 1){
+			printf("-f, -p, -t, -w and -v can not be used with -r, the checkpoint holds the program and address space\n");
+			return -1;
+		}
+
+		int fd = open(restoreFile, O_RDONLY);
+		struct stat st;
+		if (fd < 0 || fstat(fd, &st) != 0) {
+			printf("Cannot open file '%s' : %s\n", restoreFile, strerror(errno));
+			return -1;
+		}
+		checkpointSize = st.st_size;
+		checkpoint = (checkpointSize >= (long)sizeof(checkpointHeaderType)) ?
+			mmap(NULL, checkpointSize, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+		close(fd);
+
+		const checkpointHeaderType* header = (const checkpointHeaderType*)checkpoint;
+		if (checkpoint == MAP_FAILED || memcmp(header->magic, CHECKPOINTMAGIC, sizeof(header->magic)) != 0 ||
+			header->version != CHECKPOINTVERSION){
+			printf("'%s' is not a checkpoint\n", restoreFile);
+			return -1;
+		}
+
+		// any part of the geometry not given is the checkpoint's
+		if (blockSizeInWords == 0){
+			blockSizeInWords = header->wordsPerBlock;
+		}
+		if (numSets == 0){
+			numSets = header->sets;
+		}
+		if (associativity == 0){
+			associativity = header->ways;
+		}
+		if ((blockSizeInWords != header->wordsPerBlock || numSets != header->sets ||
+			associativity != header->ways) && transferFlag == 0){
+			printf("Checkpoint was taken with -b %d -s %d -a %d, use -T to warm a different cache from it\n",
+				header->wordsPerBlock, header->sets, header->ways);
+			return -1;
+		}
+
+		// the address space must be the one the checkpoint was taken in
+		pageSize = header->pageSize;
+		tlbSets = header->tlbSets;
+		tlbWays = header->tlbWays;
+		virtualIndexFlag = header->virtualIndexFlag;
+	}
+
 	if (discriptiveFlag == 1){
-		printf("File: %s\n", fname);
+		printf("File: %s\n", restoreFile != NULL ? restoreFile : fname);
 		printf("numSets: %d\n", numSets);
 		printf("blockSizeInWords: %d\n", blockSizeInWords);
 		printf("associativity: %d\n", associativity);
 		printf("discriptiveFlag: %d\n", discriptiveFlag);
+		if (pageSize > 0){
+			printf("pageSize: %d\n", pageSize);
+			printf("tlbSets: %d\n", tlbSets);
+			printf("tlbWays: %d\n", tlbWays);
+			printf("virtualIndexFlag: %d\n", virtualIndexFlag);
+		}
 	}
 
-	FILE *fp = fopen(fname, "r");
-	if (fp == NULL) {
-		printf("Cannot open file '%s' : %s\n", fname, strerror(errno));
-		return -1;
-	}
-	
-	/* count the number of lines by counting newline characters */
+	FILE *fp = NULL;
 	int line_count = 0;
-	int c;
-    while (EOF != (c=getc(fp))) {
-        if ( c == '\n' ){
-            line_count++;
+	if (restoreFile == NULL){
+		fp = (fname != NULL) ? fopen(fname, "r") : NULL;
+		if (fp == NULL) {
+			printf("Cannot open file '%s' : %s\n", fname, strerror(errno));
+			return -1;
 		}
-    }
-	// reset fp to the beginning of the file
-	rewind(fp);
+
+		/* count the number of lines by counting newline characters */
+		int c;
+		while (EOF != (c=getc(fp))) {
+			if ( c == '\n' ){
+				line_count++;
+			}
+		}
+		// reset fp to the beginning of the file
+		rewind(fp);
+	}
 
 	// Instantiate the state and the cache 2d array and its structs
 	stateType* state = (stateType*)malloc(sizeof(stateType));
 	state->pc = 0;
 
 	state->discriptiveFlag = discriptiveFlag;
-	state->sets = numSets;
-	state->ways = associativity;
-	state->wordsPerBlock = blockSizeInWords;
-
-	// Alocate our cache array the size of the number of sets/lines we have contaning pointers to the array of blocks in each set
-	state->cacheArr = malloc(state->sets * sizeof(cacheEntryType*));
-
-	// Alocate the size of the array of the sub arrays contaning the pointers to the block structs
-	for (int set = 0; set < state->sets; set++ ){
-		state->cacheArr[set] = (cacheEntryType*)malloc(state->ways * sizeof(cacheEntryType));
-
-		// Alocate the structs pointed to by each pointer of the sub array
-		for (int way = 0; way < state->ways; way++ ){
-			state->cacheArr[set][way].dirtyBit = clean;
-			state->cacheArr[set][way].validBit = invalid;
-			state->cacheArr[set][way].tag = 0;
-			state->cacheArr[set][way].cyclesSinceLastUse = 0;
-			state->cacheArr[set][way].data = (int*)malloc(state->wordsPerBlock * sizeof(int));
-			for (int word = 0; word < state->wordsPerBlock; word++ ){
-				state->cacheArr[set][way].data[word] = 0;
-			}
-		}
+	state->quietFlag = quietFlag;
+	state->totalInstrs = 0;
+	state->checkpointAt = checkpointAt;
+	state->checkpointFile = checkpointFile;
+	// Instantiate the cache backed by the state's memory and log its transfers
+	state->cache = cacheCreate();
+	if (state->cache == NULL ||
+		cacheConfigure(state->cache, blockSizeInWords, numSets, associativity, state->mem, NUMMEMORY) != 0){
+		printf("Invalid cache geometry: -b, -s and -a must be powers of two\n");
+		return -1;
+	}
+	if (quietFlag == 0){
+		state->cache->logger = print_action;
 	}
 
 	printCache(state);
@@ -708,22 +944,54 @@ int main(int argc, char** argv){
 	memset(state->mem, 0, NUMMEMORY*sizeof(int));
 	memset(state->reg, 0, NUMREGS*sizeof(int));
 
-	state->numMemory = line_count;
+	state->vm = NULL;
+	if (pageSize > 0 && initVirtualMemory(state, pageSize, tlbSets, tlbWays, virtualIndexFlag) != 0){
+		return -1;
+	}
+	if (state->vm != NULL && line_count > state->vm->numPages * pageSize){
+		printf("Program does not fit in the %d word virtual address space\n", state->vm->numPages * pageSize);
+		return -1;
+	}
 
-	char line[256];
-	
-	int i = 0;
-	while (fgets(line, sizeof(line), fp)) {
-        /* note that fgets doesn't strip the terminating \n, checking its
-           presence would allow to handle lines longer that sizeof(line) */
-		state->mem[i] = atoi(line);
-		i++;
-    }
-    fclose(fp);
+	if (restoreFile != NULL){
+		if (restoreCheckpoint(state, checkpoint, checkpointSize) != 0){
+			printf("Checkpoint '%s' is corrupt\n", restoreFile);
+			return -1;
+		}
+		munmap((void*)checkpoint, checkpointSize);
+	}
+	else{
+		state->numMemory = line_count;
+
+		char line[256];
+
+		int i = 0;
+		while (fgets(line, sizeof(line), fp)) {
+			/* note that fgets doesn't strip the terminating \n, checking its
+			   presence would allow to handle lines longer that sizeof(line) */
+			// with virtual memory the program is loaded at virtual address 0
+			if (state->vm != NULL){
+				state->mem[mapAddress(i, state)] = atoi(line);
+			}
+			else{
+				state->mem[i] = atoi(line);
+			}
+			i++;
+		}
+		fclose(fp);
+	}
+
+	signal(SIGUSR1, requestCheckpoint);
 	
 	/** Run the simulation **/
 	run(state);
 
+	if (state->vm != NULL){
+		cacheDestroy(state->vm->tlb);
+		free(state->vm->pendingWalks);
+		free(state->vm);
+	}
+	cacheDestroy(state->cache);
 	free(state);
 	free(fname);
 
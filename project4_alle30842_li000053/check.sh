@@ -0,0 +1,94 @@
+#!/bin/sh
+# Compare cacheSim's output with the golden outputs in testFiles, run by make check
+
+status=0
+checkpoint=$(mktemp)
+restored=$(mktemp)
+trap 'rm -f "$checkpoint" "$checkpoint.full" "$restored"' EXIT
+
+# instructions run before the checkpoint in the restore checks
+CHECKPOINTAT=2
+
+# the lines of an output that do not depend on the cache or TLB geometry:
+# instructions, transfers to and from the processor and machine halted
+processorView() {
+	grep -v -e "from the memory to" -e "to the memory" -e "to nowhere" -e "^tlb " -e "^page walks" -e "^walk cycles"
+}
+
+# checkTransfer "test file" "golden output" "instruction" cacheSim options...
+# Checks a run restored with -T into a one word cache from a checkpoint taken
+# before the given instruction, it must do what the rest of the golden output does
+checkTransfer() {
+	mc=$1
+	golden=$2
+	at=$3
+	shift 3
+	./cacheSim -f "$mc" "$@" -c "$at" -o "$checkpoint" > /dev/null 2>&1
+	./cacheSim -r "$checkpoint" -b 1 -s 1 -a 1 -T 2> /dev/null | processorView > "$restored"
+	lines=$(wc -l < "$restored")
+	if [ "$lines" -gt 0 ] && processorView < "$golden" | tail -n "$lines" | cmp -s - "$restored"; then
+		echo "PASS $mc $* restored with -T at instruction $at"
+	else
+		echo "FAIL $mc $* restored with -T at instruction $at"
+		status=1
+	fi
+}
+
+# checkOutput "test file" "golden output" cacheSim options...
+# Checks a full run, then runs restored from a checkpoint taken part way through
+checkOutput() {
+	mc=$1
+	golden=$2
+	shift 2
+	if ./cacheSim -f "$mc" "$@" | cmp -s - "$golden"; then
+		echo "PASS $mc $*"
+	else
+		echo "FAIL $mc $*"
+		status=1
+	fi
+
+	# a run restored from a checkpoint must print the rest of the golden output
+	./cacheSim -f "$mc" "$@" -c $CHECKPOINTAT -o "$checkpoint" > /dev/null 2>&1
+	./cacheSim -r "$checkpoint" > "$restored" 2> /dev/null
+	lines=$(wc -l < "$restored")
+	if [ "$lines" -gt 0 ] && tail -n "$lines" "$golden" | cmp -s - "$restored"; then
+		echo "PASS $mc $* restored at instruction $CHECKPOINTAT"
+	else
+		echo "FAIL $mc $* restored at instruction $CHECKPOINTAT"
+		status=1
+	fi
+
+	checkTransfer "$mc" "$golden" $CHECKPOINTAT "$@"
+}
+
+# every testN.mc.b.s.a against testN.out.b.s.a
+for mc in testFiles/*.mc.*; do
+	geometry=${mc##*.mc.}
+	b=${geometry%%.*}; rest=${geometry#*.}; s=${rest%%.*}; a=${rest#*.}
+	checkOutput "$mc" "${mc%.mc.*}.out.$geometry" -b "$b" -s "$s" -a "$a"
+done
+
+# virtual memory, physically and virtually indexed
+checkOutput testFiles/test3.mc.4.2.2 testFiles/test3.out.4.2.2.p16.t2.w1 -b 4 -s 2 -a 2 -p 16 -t 2 -w 1
+checkOutput testFiles/test3.mc.4.2.2 testFiles/test3.out.4.2.2.p16.v -b 4 -s 2 -a 2 -p 16 -v
+checkOutput testFiles/test2.mc.4.2.2 testFiles/test2.out.4.2.2.p4.t1.w1.v -b 4 -s 2 -a 2 -p 4 -t 1 -w 1 -v
+# halt's write backs miss in a one entry TLB, their walks must not refill the flushed cache
+checkOutput testFiles/test3.mc.4.2.2 testFiles/test3.out.4.2.2.p16.t1.w1.v -b 4 -s 2 -a 2 -p 16 -t 1 -w 1 -v
+checkOutput testFiles/test8.mc.4.4.4 testFiles/test8.out.4.4.4.p16.t1.w1.v -b 4 -s 4 -a 4 -p 16 -t 1 -w 1 -v
+
+# warm a new cache from a checkpoint full of dirty blocks, taken before the halt of test8
+checkTransfer testFiles/test8.mc.4.4.4 testFiles/test8.out.4.4.4 17 -b 4 -s 4 -a 4
+checkTransfer testFiles/test8.mc.4.4.4 testFiles/test8.out.4.4.4.p16.t1.w1.v 17 -b 4 -s 4 -a 4 -p 16 -t 1 -w 1 -v
+
+# the write backs of the warming belong to the run, so the totals match a run straight through
+./cacheSim -q -f testFiles/test8.mc.4.4.4 -b 4 -s 4 -a 4 | grep writeBacks > "$checkpoint.full"
+./cacheSim -f testFiles/test8.mc.4.4.4 -b 4 -s 4 -a 4 -c 17 -o "$checkpoint" > /dev/null 2>&1
+./cacheSim -q -r "$checkpoint" -b 1 -s 1 -a 1 -T | grep writeBacks > "$restored"
+if cmp -s "$checkpoint.full" "$restored"; then
+	echo "PASS testFiles/test8.mc.4.4.4 write backs restored with -T"
+else
+	echo "FAIL testFiles/test8.mc.4.4.4 write backs restored with -T"
+	status=1
+fi
+
+exit $status
@@ -0,0 +1,25 @@
+transferring word [0-3] from the memory to the cache
+transferring word [49152-49155] from the memory to the cache
+transferring word [0-0] from the cache to the processor
+lw 1 0 4
+transferring word [4-7] from the memory to the cache
+transferring word [4-4] from the cache to the processor
+transferring word [1-1] from the cache to the processor
+lw 1 0 12
+transferring word [12-15] from the memory to the cache
+transferring word [12-12] from the cache to the processor
+transferring word [2-2] from the cache to the processor
+lw 1 0 20
+transferring word [4-7] from the cache to nowhere
+transferring word [20-23] from the memory to the cache
+transferring word [12-15] from the cache to nowhere
+transferring word [49156-49159] from the memory to the cache
+transferring word [20-20] from the cache to the processor
+transferring word [3-3] from the cache to the processor
+halt 0 0 0
+machine halted
+tlb hits: 0
+tlb misses: 4
+tlb hit rate: 0.00%
+page walks: 4
+walk cycles: 202
@@ -0,0 +1,23 @@
+transferring word [0-3] from the memory to the cache
+transferring word [61440-61443] from the memory to the cache
+transferring word [0-0] from the cache to the processor
+lw 1 0 0
+transferring word [0-0] from the cache to the processor
+transferring word [1-1] from the cache to the processor
+sw 1 0 20
+transferring word [20-23] from the memory to the cache
+transferring word [20-20] from the processor to the cache
+transferring word [2-2] from the cache to the processor
+sw 1 0 52
+transferring word [52-55] from the memory to the cache
+transferring word [52-52] from the processor to the cache
+transferring word [3-3] from the cache to the processor
+halt 0 0 0
+transferring word [20-23] from the cache to the memory
+transferring word [52-55] from the cache to the memory
+machine halted
+tlb hits: 2
+tlb misses: 3
+tlb hit rate: 40.00%
+page walks: 3
+walk cycles: 102
@@ -0,0 +1,109 @@
+transferring word [0-3] from the memory to the cache
+transferring word [61440-61443] from the memory to the cache
+transferring word [0-0] from the cache to the processor
+lw 1 0 18
+transferring word [16-19] from the memory to the cache
+transferring word [18-18] from the cache to the processor
+transferring word [1-1] from the cache to the processor
+sw 1 0 36
+transferring word [36-39] from the memory to the cache
+transferring word [36-36] from the processor to the cache
+transferring word [2-2] from the cache to the processor
+sw 1 0 56
+transferring word [56-59] from the memory to the cache
+transferring word [56-56] from the processor to the cache
+transferring word [3-3] from the cache to the processor
+sw 1 0 76
+transferring word [76-79] from the memory to the cache
+transferring word [61444-61447] from the memory to the cache
+transferring word [76-76] from the processor to the cache
+transferring word [4-7] from the memory to the cache
+transferring word [4-4] from the cache to the processor
+sw 1 0 80
+transferring word [80-83] from the memory to the cache
+transferring word [80-80] from the processor to the cache
+transferring word [5-5] from the cache to the processor
+sw 1 0 100
+transferring word [100-103] from the memory to the cache
+transferring word [100-100] from the processor to the cache
+transferring word [6-6] from the cache to the processor
+sw 1 0 120
+transferring word [120-123] from the memory to the cache
+transferring word [120-120] from the processor to the cache
+transferring word [7-7] from the cache to the processor
+sw 1 0 140
+transferring word [140-143] from the memory to the cache
+transferring word [61448-61451] from the memory to the cache
+transferring word [140-140] from the processor to the cache
+transferring word [8-11] from the memory to the cache
+transferring word [8-8] from the cache to the processor
+sw 1 0 144
+transferring word [0-3] from the cache to nowhere
+transferring word [144-147] from the memory to the cache
+transferring word [144-144] from the processor to the cache
+transferring word [9-9] from the cache to the processor
+sw 1 0 164
+transferring word [36-39] from the cache to the memory
+transferring word [164-167] from the memory to the cache
+transferring word [164-164] from the processor to the cache
+transferring word [10-10] from the cache to the processor
+sw 1 0 184
+transferring word [56-59] from the cache to the memory
+transferring word [184-187] from the memory to the cache
+transferring word [184-184] from the processor to the cache
+transferring word [11-11] from the cache to the processor
+sw 1 0 204
+transferring word [204-207] from the memory to the cache
+transferring word [61452-61455] from the memory to the cache
+transferring word [204-204] from the processor to the cache
+transferring word [76-79] from the cache to the memory
+transferring word [12-15] from the memory to the cache
+transferring word [12-12] from the cache to the processor
+sw 1 0 208
+transferring word [61440-61443] from the cache to nowhere
+transferring word [208-211] from the memory to the cache
+transferring word [208-208] from the processor to the cache
+transferring word [13-13] from the cache to the processor
+sw 1 0 228
+transferring word [61444-61447] from the cache to nowhere
+transferring word [228-231] from the memory to the cache
+transferring word [228-228] from the processor to the cache
+transferring word [14-14] from the cache to the processor
+sw 1 0 248
+transferring word [120-123] from the cache to the memory
+transferring word [248-251] from the memory to the cache
+transferring word [4-7] from the cache to nowhere
+transferring word [61444-61447] from the memory to the cache
+transferring word [248-248] from the processor to the cache
+transferring word [15-15] from the cache to the processor
+sw 1 0 268
+transferring word [140-143] from the cache to the memory
+transferring word [268-271] from the memory to the cache
+transferring word [16-19] from the cache to nowhere
+transferring word [61456-61459] from the memory to the cache
+transferring word [268-268] from the processor to the cache
+transferring word [80-83] from the cache to the memory
+transferring word [16-19] from the memory to the cache
+transferring word [144-147] from the cache to the memory
+transferring word [61440-61443] from the memory to the cache
+transferring word [16-16] from the cache to the processor
+sw 1 0 272
+transferring word [208-211] from the cache to the memory
+transferring word [272-275] from the memory to the cache
+transferring word [272-272] from the processor to the cache
+transferring word [17-17] from the cache to the processor
+halt 0 0 0
+transferring word [272-275] from the cache to the memory
+transferring word [164-167] from the cache to the memory
+transferring word [228-231] from the cache to the memory
+transferring word [100-103] from the cache to the memory
+transferring word [184-187] from the cache to the memory
+transferring word [248-251] from the cache to the memory
+transferring word [268-271] from the cache to the memory
+transferring word [204-207] from the cache to the memory
+machine halted
+tlb hits: 1
+tlb misses: 37
+tlb hit rate: 2.63%
+page walks: 37
+walk cycles: 1423